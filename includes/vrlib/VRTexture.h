@@ -0,0 +1,24 @@
+#ifndef VRTEXTURE_H
+#define VRTEXTURE_H
+
+#include <vrlib_vr/image.h>
+
+// one persistent texture showing the volume renderer's image; each
+// update streams only the changed rectangle through a pixel buffer
+// object. Texel (x, y) is image pixel (u, v), so the quad mirrors s
+// to show u running right to left as in the ppm output.
+class VRTexture {
+  private:
+    unsigned int tex, pbo;
+    int width, height;
+    image_bounds_type shown;   // texels holding the last image, rest is black
+
+  public:
+    VRTexture(int width, int height);
+    ~VRTexture();
+
+    void update(image_type *image);
+    unsigned int getID() { return tex; }
+};
+
+#endif
@@ -0,0 +1,81 @@
+/////////////////////////////////////////////////////////////////////
+//
+//                    Headless Batch Rendering
+//
+//   A job file lists the frames to render from one volume; the
+//   volume is loaded and preprocessed once into a volumeData
+//   (volume_data.h) and the frames go to a volumeRender per thread
+//   sharing it, a whole frame at a time, while an imageWriter
+//   encodes and writes the finished ones.
+//
+//   Job files are read a line at a time; # starts a comment.
+//
+//     volume file            the volume (first, once)
+//     size udim vdim         image size of the frames that follow
+//     cmap file              color table of the frames that follow
+//     view alpha beta gamma out
+//                            one frame
+//     orbit x|y|z n from to alpha beta gamma out
+//                            n frames turning the x, y or z angle
+//                            from from up to (not including) to,
+//                            the other two angles fixed
+//     key alpha beta gamma   a keyframe of a camera path
+//     path n out             n frames through the keys given since
+//                            the last path, first to last key,
+//                            angles interpolated linearly
+//
+//   out is a printf pattern of the frame number in the job with
+//   exactly one integer conversion (e.g. f%05d.png, see
+//   image_frame_name()); the format follows its extension
+//   (image_io.h).
+//   size and cmap must come before the first frame.
+//
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "render.h"
+#include "image_io.h"
+#include "volume_data.h"
+
+struct batchFrame {
+  float angles[3];             // alpha, beta, gamma of set_view()
+  int udim, vdim;
+  int cmap;                    // index into batchJob::cmaps
+  std::string out;
+};
+
+class batchJob {
+
+public:
+  std::string volume;
+  std::vector<std::string> cmaps;
+  std::vector<batchFrame> frames;
+
+  // 1 on success; errors are printed with their line
+  int read(const char* fname);
+};
+
+class batchRender {
+
+  std::shared_ptr<const volumeData> data;
+  std::vector<volumeRender*> workers;
+  std::vector<colorTable> tables;
+
+  int load_tables(const batchJob& job);
+
+public:
+  // nthreads renderers (0: one per core) of d
+  batchRender(std::shared_ptr<const volumeData> d, int nthreads = 0);
+  ~batchRender();
+
+  // render every frame of job; the number of frames written, -1 if
+  // a color table can't be read. seconds: wall time, writes included
+  int render(const batchJob& job, double* seconds = NULL);
+};
+
+#endif
@@ -0,0 +1,30 @@
+/*
+ *  Compositing kernels
+ *
+ * Purpose:
+ *
+ * The per pixel OVER operator on rows of 8-bit premultiplied RGBA
+ * pixels, in integer arithmetic with rounding to nearest:
+ *
+ *     out = front                                 if front.a == 0
+ *     out = front + round(back*(255-front.a)/255) otherwise
+ *
+ * (saturated at 255).  A OVER B is composite_row(A, A, B); A UNDER
+ * B, i.e. B OVER A, is composite_row(A, B, A).  The kernel is chosen
+ * once at run time: AVX2, SSE4.1 or plain C.  Rows are independent,
+ * so a row range can be handed to each thread.
+ */
+
+#ifndef COMPOSITE_KERNELS_H
+#define COMPOSITE_KERNELS_H
+
+#include "image.h"
+
+  /* out[i] = front[i] OVER back[i], i < n; out may be front or back */
+extern void composite_row( pixel *out, const pixel *front,
+			   const pixel *back, int n );
+
+  /* name of the kernel in use: "avx2", "sse4.1" or "c" */
+extern const char *composite_kernel_name( void );
+
+#endif /* COMPOSITE_KERNELS_H */
@@ -0,0 +1,85 @@
+/////////////////////////////////////////////////////////////////////
+//
+//            Sort-Last Compositing Between Renderer Processes
+//
+//   Every rank of a sockComm group renders one subvolume into a
+//   partial image; the compositor combines them into the final
+//   frame on rank 0.  The schedules are all radix-k: the group
+//   size n is factored as k1*k2*...*km and in round i the ranks
+//   form groups of ki that differ only in digit i of their rank
+//   (mixed radix, k1 least significant).  Each member of a group
+//   keeps 1/ki of the image region it is responsible for, sends
+//   the other pieces to their owners and composites what it gets,
+//   so after m rounds every rank holds the finished n-th of the
+//   frame and sends it to rank 0.
+//
+//     direct send    one round, k1 = n
+//     binary swap    k = 2 every round (n a power of two)
+//     radix-k        rounds of at most k (default 4)
+//
+//   The subvolumes follow the same factors, so that every group
+//   composites neighbouring pieces in a known order: the volume is
+//   cut into km slabs along its longest axis, each slab into
+//   k(m-1) along its longest axis, and so on.  The members of a
+//   round-i group are the ki slabs of one such cut; the side of
+//   the cut the viewer is on gives their front to back order.
+//
+//   By default the pieces travel run length encoded (image_rle.h):
+//   a partial image is mostly transparent, and the encoded pieces
+//   are composited without expanding them.  set_rle(0) sends the
+//   plain rectangles instead.
+//
+
+#ifndef COMPOSITE_NET_H
+#define COMPOSITE_NET_H
+
+#include <vector>
+
+#include "render.h"
+#include "sock_comm.h"
+
+enum composite_schedule {
+  DIRECT_SEND = 0,
+  BINARY_SWAP = 1,
+  RADIX_K     = 2
+};
+
+class netCompositor {
+
+  sockComm *comm;
+  std::vector<int> factors;    // group size per round
+  std::vector<int> axis;       // axis of the cut merged in each round
+  int lo[3], hi[3];            // subvolume of this rank
+
+  int digit(int round);
+  int group_member(int round, int d);   // rank with digit d in round
+  int use_rle;
+
+  image_type* composite_rle(image_type* partial, int udim, int vdim,
+                            Matrix data_to_screen);
+
+public:
+  // radix is the largest group size for RADIX_K
+  netCompositor(sockComm* comm, int schedule, int radix,
+                int xdim, int ydim, int zdim);
+
+  // 0 if the schedule does not fit the group size
+  int ok() { return !factors.empty() || comm->size() == 1; }
+  int rounds() { return (int)factors.size(); }
+
+  void set_rle(int on) { use_rle = on; }
+
+  void get_subvolume(int l[3], int h[3]) {
+    for (int i=0; i<3; i++) { l[i] = lo[i]; h[i] = hi[i]; } }
+
+  // Composite the partial image of this rank for a udim x vdim
+  // frame seen through data_to_screen. Returns the full frame
+  // on rank 0 (free with image_free) and NULL elsewhere.
+  image_type* composite(image_type* partial, int udim, int vdim,
+                        Matrix data_to_screen);
+
+  double exchange_seconds;     // last composite(): time in the rounds
+  double gather_seconds;       //   and in the final gather
+};
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ *  Float images
+ *
+ * Purpose:
+ *
+ * Premultiplied RGBA in 32 bit floats, for partial images that go
+ * through many composites: image_type rounds to 8 bits after every
+ * one, a float image keeps full precision until fimage_to_image
+ * at output.  Pixels are 16 bytes, 16 byte aligned, and the rows
+ * are packed one after the other.  As with image_type, header and
+ * pixels are one block of totalsize bytes.
+ */
+
+#ifndef FIMAGE_H
+#define FIMAGE_H
+
+#include "image.h"
+
+typedef struct alignas(16) fpixel_tag
+{
+  float r, g, b, a;
+} fpixel;
+
+typedef struct fimage_tag
+{
+  image_bounds_type b;		/* bounds for image */
+  int rowsize;		     /* rowsize in pixels (for indexing) */
+  int totalsize;	     /* total size in bytes (for msg passing) */
+  fpixel image[1];	     /* 16 byte aligned, allocated with the header */
+} fimage_type;
+
+
+/* Macros */
+
+#define fimage_free(img) (image_pool_free(img))
+
+#define fimage_index(img,u,v) \
+  ((img)->image + (((u)-(img)->b.umin) + ((v)-(img)->b.vmin)*(img)->rowsize))
+
+#define fimage_empty_p(img)  \
+   ((img)->b.umin > (img)->b.umax || (img)->b.vmin > (img)->b.vmax)
+
+
+/* Prototypes */
+
+extern fimage_type *fimage_new( int umin, int umax, int vmin, int vmax );
+
+extern void fimage_zero_rect( fimage_type *img,
+			      int umin, int umax, int vmin, int vmax );
+
+  /* out[i] = front[i] OVER back[i]; out may be front or back */
+extern void fcomposite_row( fpixel *out, const fpixel *front,
+			    const fpixel *back, int n );
+
+  /* image_composite for float images */
+extern void fimage_composite( fimage_type *imgA, image_bounds_type *Abnds,
+			      fimage_type *imgB, enum op_code op );
+
+  /* Conversions; to 8 bits rounds to nearest as the renderer does */
+extern fimage_type *fimage_from_image( image_type *img );
+extern image_type *fimage_to_image( fimage_type *img );
+
+#endif /* FIMAGE_H */
@@ -0,0 +1,51 @@
+/////////////////////////////////////////////////////////////////////
+//
+//                     Frame Time Budget
+//
+//   Keeps interactive frames of a volumeRender near a target time
+//   by stepping along a ladder of quality settings: the early ray
+//   termination opacity, the sample spacing, the pyramid level
+//   bias and the fraction of pixels traced (set_quality, set_lod).
+//   Each rung is given its expected cost relative to full quality;
+//   the measured time of every frame updates an estimate of the
+//   full quality cost, and the next frame takes the best rung
+//   predicted to fit.  Going back up needs some room to spare, so
+//   the quality does not flicker between two rungs.
+//
+//   Frames that are not interactive (interaction has stopped) are
+//   always rendered at full quality; when they go through execute()
+//   their time goes into the estimate too (renderSession does so for
+//   all but progressive frames, whose passes can't be timed as one).
+//   The budget sets the renderer's lod to automatic.
+//
+
+#ifndef FRAME_BUDGET_H
+#define FRAME_BUDGET_H
+
+#include "render.h"
+
+class frameBudget {
+
+  double target;               // seconds, 0: off
+  double full_cost;            // estimated seconds of a full frame, 0: unknown
+  int rung;                    // ladder rung of the last frame
+
+  void set_rung(volumeRender& vr, int r);
+
+public:
+  frameBudget(double target_ms = 0);
+
+  void   set_target(double ms) { target = ms/1000.0; }
+  double get_target() { return target*1000.0; }
+
+  // full quality settings, e.g. before another kind of render
+  void full_quality(volumeRender& vr) { set_rung(vr, 0); }
+
+  // render one frame, interactive or not; returns its time in ms
+  double execute(volumeRender& vr, int interactive);
+
+  int get_rung() { return rung; }      // 0 is full quality
+  static int num_rungs();
+};
+
+#endif
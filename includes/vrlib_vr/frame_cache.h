@@ -0,0 +1,106 @@
+/////////////////////////////////////////////////////////////////////
+//
+//                  Cache of Finished Frames
+//
+//   Frames are kept run length encoded (image_rle.h) under the key
+//   volumeRender::frame_key() gives for them: a hash of the data
+//   version, view, image size, lookup table contents and quality
+//   settings, so any change to those misses.  The most recently
+//   used frames stay in memory up to a byte budget; with a
+//   directory, every frame also goes to disk (one <key>.vrf file
+//   each, written atomically) and memory misses are looked up
+//   there, with the least recently used files removed beyond a
+//   second budget.  The disk part survives restarts; file times
+//   record use across runs.
+//
+//   Frames whose key is 0 (unknown data version and the like, see
+//   frame_key()) are always rendered.  All calls may come from
+//   several threads; files are read and written without holding
+//   the cache's lock.
+//
+
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+#include <string>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+#include "render.h"
+#include "image.h"
+#include "image_rle.h"
+
+#define FRAME_CACHE_MAGIC 0x76726663    // "vrfc"
+
+struct frame_cache_stats {
+  long hits;                   // from memory
+  long disk_hits;
+  long misses;
+  long uncacheable;            // key 0
+  size_t bytes, disk_bytes;    // held now
+  int frames, disk_frames;
+};
+
+class frameCache {
+
+  struct entry {
+    hash64_t key;
+    image_bounds_type b;       // bounds of the image it came from
+    rle_image_type* rle;
+  };
+
+  struct disk_entry {
+    hash64_t key;
+    size_t bytes;
+  };
+
+  std::mutex lock;
+  std::list<entry> lru;        // most recent first
+  std::unordered_map<hash64_t, std::list<entry>::iterator> index;
+  size_t max_bytes, bytes;
+
+  std::string dir;             // empty: memory only
+  size_t max_disk, disk_bytes;
+  std::list<disk_entry> disk_lru;              // most recent first
+  std::unordered_map<hash64_t, std::list<disk_entry>::iterator> disk;
+  unsigned serial;             // of temporary file names
+
+  frame_cache_stats st;
+
+  std::string file_name(hash64_t key);
+  void drop_oldest();
+  void keep(hash64_t key, image_bounds_type b, rle_image_type* rle);
+  void disk_used(hash64_t key, size_t bytes, std::vector<std::string>& drop);
+  void disk_forget(hash64_t key);
+  // no lock needed
+  static rle_image_type* read_file(const std::string& path, hash64_t key,
+                                   image_bounds_type* b);
+  static size_t write_file(const std::string& path, const std::string& tmp,
+                           hash64_t key, image_bounds_type b,
+                           rle_image_type* rle);
+  static image_type* expand(image_bounds_type b, rle_image_type* rle);
+
+public:
+  frameCache(size_t max_bytes = (size_t)256 << 20);
+  ~frameCache();
+
+  void set_budget(size_t max_bytes);
+
+  // also keep frames in dir (created if missing), at most max_bytes
+  // of them; 0 if dir can't be used
+  int set_disk(const char* dir, size_t max_bytes);
+
+  // a copy of the frame (free with image_free), or NULL
+  image_type* lookup(hash64_t key);
+  void insert(hash64_t key, image_type* img);
+
+  // vr.execute(), or vr.image from the cache; 1 if it was cached
+  int execute(volumeRender& vr);
+
+  void get_stats(frame_cache_stats* s);
+  void print_stats();
+};
+
+#endif
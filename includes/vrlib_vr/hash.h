@@ -0,0 +1,20 @@
+////////////////////////////////////////////////////////
+//
+//   64 bit non-cryptographic hashing for cache keys
+//
+
+#ifndef VR_HASH_H
+#define VR_HASH_H
+
+#include <stddef.h>
+
+typedef unsigned long long hash64_t;
+
+// hash n bytes, chaining from seed
+hash64_t hash64(const void* data, size_t n, hash64_t seed = 0);
+
+// hash of a large buffer computed in parallel: the chunk hashes
+// are hashed again, so the result does not depend on nthreads
+hash64_t hash64_parallel(const void* data, size_t n, int nthreads = 0);
+
+#endif
@@ -23,9 +23,15 @@
  */
 typedef unsigned char byte;	/* a convenient data type */
 
+/* A pixel is 4 bytes; define VRLIB_LONG_PIXEL for the original    */
+/*  layout, where the long made it 8 bytes on 64 bit machines        */
 typedef union pixel_u	/* A pixel can be treated as a long or R,G,B,A */
 {
+#ifdef VRLIB_LONG_PIXEL
   unsigned long lp;	
+#else
+  unsigned int lp;
+#endif
   struct pixel_b { byte a,b,g,r; } bp;   /* order of bytes must matches X11 */
 } pixel;
 
@@ -50,8 +56,8 @@ typedef struct image_tag
 
 /* Macros */
 
-  /* Free memory for an image */
-#define image_free(img) (free(img))
+  /* Free memory for an image (back to the image pool) */
+#define image_free(img) (image_pool_free(img))
 
   /* bounds check whether a u,v coordinate is inside an image */
 #define in_image_p(img,u,v)     \
@@ -77,6 +83,18 @@ typedef struct image_tag
 
 /* Prototypes */
 
+  /* Image memory: blocks are kept per size class and reused, so */
+  /*  images of a steady frame size cost no heap allocation.     */
+  /*  Thread safe.                                               */
+extern void *image_pool_alloc( size_t size );
+extern void image_pool_free( void *p );
+
+  /* Keep at most max_bytes of free blocks (default 1G) */
+extern void image_pool_trim( size_t max_bytes );
+
+  /* Free bytes held, and blocks that came from the heap so far */
+extern void image_pool_stats( size_t *cached, size_t *heap_allocs );
+
   /* Allocate memory for a new image */
 extern image_type *image_new( int umin, int umax, int vmin, int vmax );
 
@@ -89,6 +107,11 @@ enum op_code {OVER,UNDER};
 extern  void image_composite( image_type *imgA, image_bounds_type *Abnds,
 			      image_type *imgB, enum op_code op);
 
+/* Same, with the scanlines split among nthreads threads */
+extern  void image_composite_mt( image_type *imgA, image_bounds_type *Abnds,
+				 image_type *imgB, enum op_code op,
+				 int nthreads );
+
 /* Extract a subimage */
 extern image_type *
 image_extract
@@ -0,0 +1,124 @@
+/////////////////////////////////////////////////////////////////////
+//
+//                        Writing Images to Files
+//
+//   An image_type covering part of a udim x vdim frame is written
+//   as the whole frame, black outside its bounds, in the same
+//   orientation as the original ASCII ppm output: v = 0 is the top
+//   row and u runs from right to left.  Rows are produced one at a
+//   time straight from the image.
+//
+//     IMG_PPM_ASCII   P3, as out_to_image used to write
+//     IMG_PPM         P6
+//     IMG_RGBA        raw premultiplied r,g,b,a bytes, rows top to
+//                     bottom, no header
+//     IMG_PNG         8 bit RGB; the zlib stream uses stored blocks
+//                     (no compression), one IDAT chunk per row
+//     IMG_SGI         SGI (iris) RGB, ITYPE_RLE (iris_image.h)
+//
+//   imageStream writes a frame a band of rows at a time, top to
+//   bottom, for frames too big to be held as one image; only a row
+//   is buffered (and the SGI row tables, 24 bytes a row).
+//
+//   imageWriter does the encoding and writing on a thread of its
+//   own, so a batch of frames can render the next frame while the
+//   last one goes to disk.
+//
+
+#ifndef IMAGE_IO_H
+#define IMAGE_IO_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "image.h"
+
+enum image_format {
+  IMG_AUTO = -1,        // from the file name extension
+  IMG_PPM_ASCII = 0,
+  IMG_PPM,
+  IMG_RGBA,
+  IMG_PNG,
+  IMG_SGI
+};
+
+// .ppm .rgba/.raw .png .rgb/.sgi; IMG_PPM if unknown
+int image_format_from_name(const char* fname);
+
+// the file name of frame n: pattern with n in place of its one
+// integer conversion (%d, %05d, ...), %% for a %. 0 if pattern has
+// no or more than one such conversion, any other one, or the name
+// doesn't fit in size bytes.
+int image_frame_name(const char* pattern, int n, char* name, size_t size);
+
+// 1 on success
+int image_write(image_type* img, int udim, int vdim, const char* fname,
+                int format = IMG_AUTO);
+
+class imageStream {
+
+  FILE* out;
+  std::string fname;
+  int format, udim, vdim;
+  int next;                     // next frame row
+  int ok;
+  std::vector<unsigned char> row, buf;
+  unsigned s1, s2;              // png adler32
+  std::vector<unsigned char> tables;      // sgi row starts and lengths
+  unsigned offset;              // sgi: where the next row goes
+
+  int put_row(int r);
+
+public:
+  imageStream();
+  ~imageStream();               // closes
+
+  // write the header of a udim x vdim frame; 1 on success
+  int open(const char* fname, int udim, int vdim, int format = IMG_AUTO);
+
+  // the next nrows rows of the frame from img (black outside its
+  // bounds); img only needs to cover those rows
+  int write_rows(image_type* img, int nrows);
+  int rows_written() { return next; }
+
+  // finish the file; 1 if every row was written
+  int close();
+};
+
+class imageWriter {
+
+  struct job {
+    image_type* img;
+    int udim, vdim, format;
+    std::string fname;
+  };
+
+  std::deque<job> queue;
+  size_t max_queue;
+  int stop, busy, failed;
+  std::mutex lock;
+  std::condition_variable wake, done;
+  std::thread worker;
+
+  void run();
+
+public:
+  // at most max_queue frames wait; submit() blocks beyond that
+  imageWriter(int max_queue = 4);
+  ~imageWriter();               // writes what is queued
+
+  // Queue img for writing; the writer takes it over and frees it
+  // (pass image_dup(vr.image) to keep rendering into vr.image).
+  void submit(image_type* img, int udim, int vdim, const char* fname,
+              int format = IMG_AUTO);
+
+  void flush();                 // wait until the queue is written
+  int  errors();                // frames that failed so far
+};
+
+#endif
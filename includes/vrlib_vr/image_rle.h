@@ -0,0 +1,86 @@
+/*
+ *  Run length encoded images
+ *
+ * Purpose:
+ *
+ * A partial image from a subvolume is mostly transparent.  The
+ * encoded form keeps only the runs of pixels with a != 0, row by
+ * row: rowstart[] gives the first run of every row (as in the
+ * rowstart/rowsize tables of ITYPE_RLE iris images) and every run
+ * records its first column, length and where its pixels start.
+ * Transparent pixels leave both OVER and UNDER unchanged, so
+ * compositing only has to look at the runs.
+ *
+ * Like image_type, the header, row table, runs and pixels are
+ * one contiguous block of totalsize bytes that can be sent as a
+ * single message; the tables are found through byte offsets.
+ */
+
+#ifndef IMAGE_RLE_H
+#define IMAGE_RLE_H
+
+#include "image.h"
+
+typedef struct rle_run_tag
+{
+  int u;                /* first column */
+  int len;              /* pixels in the run */
+  int pix;              /* index of its first pixel */
+} rle_run;
+
+typedef struct rle_image_tag
+{
+  image_bounds_type b;  /* bounds of the non-transparent pixels */
+  int nruns;
+  int npixels;
+  int totalsize;        /* total size in bytes (for msg passing) */
+  int runs_offset;      /* byte offsets from the header */
+  int pixels_offset;
+  int rowstart[1];      /* vmax-vmin+2 entries: the runs of row v */
+                        /*  are [rowstart[v-vmin], rowstart[v-vmin+1]) */
+} rle_image_type;
+
+
+/* Macros */
+
+#define rle_free(img) (image_pool_free(img))
+
+#define rle_runs(img) \
+  ((rle_run *)((char *)(img) + (img)->runs_offset))
+
+#define rle_pixels(img) \
+  ((pixel *)((char *)(img) + (img)->pixels_offset))
+
+#define rle_empty_p(img) ((img)->nruns == 0)
+
+
+/* Prototypes */
+
+  /* Encode the non-transparent pixels of an image */
+extern rle_image_type *rle_encode( image_type *img );
+
+  /* Encode the part of an image within bounds b */
+extern rle_image_type *rle_encode_rect( image_type *img,
+					image_bounds_type *b );
+
+  /* Back to a full rectangle over the encoded bounds */
+extern image_type *rle_decode( rle_image_type *rle );
+
+  /* Write the runs into img (which must cover them); other */
+  /*  pixels are left alone */
+extern void rle_copy_into( image_type *img, rle_image_type *rle );
+
+  /* The runs within bounds b */
+extern rle_image_type *rle_extract( rle_image_type *in,
+				    image_bounds_type *b );
+
+  /* image_composite with an encoded B: only B's runs are touched */
+extern void image_composite_rle( image_type *imgA, image_bounds_type *Abnds,
+				 rle_image_type *imgB, enum op_code op );
+
+  /* Composite two encoded images into a new encoded image */
+extern rle_image_type *rle_composite( rle_image_type *imgA,
+				      rle_image_type *imgB,
+				      enum op_code op );
+
+#endif /* IMAGE_RLE_H */
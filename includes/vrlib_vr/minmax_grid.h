@@ -0,0 +1,39 @@
+////////////////////////////////////////////////////////
+//
+//   Brick min/max grid
+//
+//   The value range of every MMG_BRICK^3 block of voxels.
+//   The renderer uses it to skip blocks that the current
+//   transfer function maps to zero opacity.
+//
+
+#ifndef MINMAX_GRID_H
+#define MINMAX_GRID_H
+
+#include <stddef.h>
+
+#define MMG_SHIFT 3                  // brick edge is 1<<MMG_SHIFT voxels
+#define MMG_BRICK (1<<MMG_SHIFT)
+
+typedef struct minmax_grid_tag
+{
+  int bxdim, bydim, bzdim;     /* number of bricks along x, y, z */
+  size_t capacity;             /* allocated bricks (kept across rebuilds) */
+  float *bmin, *bmax;          /* per-brick value range.  Each brick also */
+                               /* covers the one voxel overlap that */
+                               /* trilinear interpolation reads */
+} minmax_grid;
+
+  /* Start with an empty grid */
+void minmax_grid_init(minmax_grid *g);
+
+  /* Size the grid for a volume; reuses the old arrays when large enough */
+int  minmax_grid_alloc(minmax_grid *g, int xdim, int ydim, int zdim);
+
+  /* Fill brick slabs [bz0, bz1) from the volume data */
+void minmax_grid_build(minmax_grid *g, REAL *data,
+                       int xdim, int ydim, int zdim, int bz0, int bz1);
+
+void minmax_grid_free(minmax_grid *g);
+
+#endif
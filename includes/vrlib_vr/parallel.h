@@ -0,0 +1,39 @@
+////////////////////////////////////////////////////////
+//
+//   Small threading helpers shared by the preprocessing
+//   and rendering drivers.
+//
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <thread>
+#include <vector>
+
+// number of worker threads to use when the caller passes 0
+inline int default_threads()
+{
+  int n = (int)std::thread::hardware_concurrency();
+  return n > 0 ? n : 1;
+}
+
+// Split [0, n) into contiguous chunks and call f(begin, end) for
+// each on its own thread. The calling thread runs the last chunk.
+template <class F>
+void parallel_chunks(int n, int nthreads, F f)
+{
+  if (nthreads <= 0) nthreads = default_threads();
+  if (nthreads > n) nthreads = n;
+  if (nthreads <= 1) {
+    if (n > 0) f(0, n);
+    return;
+  }
+
+  std::vector<std::thread> workers;
+  for (int i=0; i<nthreads-1; i++)
+    workers.push_back(std::thread(f, n*i/nthreads, n*(i+1)/nthreads));
+  f(n*(nthreads-1)/nthreads, n);
+  for (size_t i=0; i<workers.size(); i++) workers[i].join();
+}
+
+#endif
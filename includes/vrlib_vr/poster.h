@@ -0,0 +1,59 @@
+/////////////////////////////////////////////////////////////////////
+//
+//                    Tiled Poster Rendering
+//
+//   Renders a frame too big to hold in memory (a 32k x 32k print
+//   is 4 GB of pixels) one band of tile rows at a time.  The tiles
+//   of a band are handed out to a volumeRender per thread, each
+//   restricted to its tile with set_window(); the finished band
+//   goes to an imageStream on a thread of its own while the next
+//   band renders.  At most two bands and one tile per thread are
+//   alive, whatever the frame size.
+//
+//   The renderers share one volumeData (volume_data.h) and the
+//   color table.  All of them use the same view, so the tiles fit
+//   together without seams.
+//
+
+#ifndef POSTER_H
+#define POSTER_H
+
+#include <vector>
+#include <memory>
+
+#include "render.h"
+#include "image_io.h"
+#include "volume_data.h"
+
+class posterRender {
+
+  std::shared_ptr<const volumeData> data;
+  std::vector<volumeRender*> workers;
+  colorTable table;
+
+  int udim, vdim;
+  int tile;                    // tile width and band height (pixels)
+
+public:
+  // nthreads renderers (0: one per core) of d
+  posterRender(std::shared_ptr<const volumeData> d, int nthreads = 0);
+  // the same for a volume in memory; grad may be NULL, the gradient
+  // is then computed here
+  posterRender(int xdim, int ydim, int zdim, REAL* volume, uvw* grad,
+               int nthreads = 0);
+  ~posterRender();
+
+  void set_minmax_grid(minmax_grid* g);
+  void set_image_size(int usize, int vsize);
+  void set_tile_size(int t) { tile = t > 0 ? t : 256; }
+  int  readCmapFile(char* filename);
+  void set_view(float xA, float yA, float zA);
+
+  // render the frame straight into fname; 1 on success
+  int render(const char* fname, int format = IMG_AUTO);
+
+  // pixel memory of the bands and tiles in flight
+  size_t peak_bytes();
+};
+
+#endif
@@ -0,0 +1,116 @@
+/////////////////////////////////////////////////////////////////////
+//
+//               Persistent Cache of Preprocessed Data
+//
+//   Everything the renderer derives from a raw volume (gradient,
+//   brick min/max grid, statistics, resolution pyramid) is stored in a sidecar
+//   directory next to the volume file, <volume>.vrcache/, one
+//   blob per artifact.  Blobs are page aligned so a warm start
+//   only maps files: the volume itself is mapped as well, nothing
+//   is read or recomputed.
+//
+//   Every blob header records the content hash of the volume file
+//   and a hash of the parameters the artifact was built with
+//   (encoding, brick size, format version).  A mismatch means the
+//   blob is stale; it is rebuilt and replaced atomically.  The
+//   content hash itself is only recomputed when the file size or
+//   modification time differs from the last run (or with verify).
+//
+//   VRLIB_NO_CACHE=1 in the environment turns the cache off (all
+//   artifacts are computed in memory), VRLIB_CACHE_DIR=dir puts
+//   the sidecar directories under dir.  If the directory is not
+//   writable the artifacts are computed in memory as well.
+//
+
+#ifndef PREPROC_CACHE_H
+#define PREPROC_CACHE_H
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "render.h"
+#include "hash.h"
+#include "pyramid.h"
+
+#define PREPROC_CACHE_VERSION 1
+
+// gradient encodings the renderer understands
+enum gradient_encoding {
+  GRADIENT_FLOAT32 = 0         // uvw, three REALs per voxel
+};
+
+#define STATS_BINS 256
+
+typedef struct volume_stats_tag
+{
+  float vmin, vmax;
+  float mean, stddev;
+  unsigned int histogram[STATS_BINS];   // over [vmin, vmax]
+} volume_stats;
+
+class preprocCache {
+
+  struct blob {
+    std::string name;
+    void *map;  size_t maplen;   // mapped blob file
+    void *heap;                  // or built in memory
+    void *payload;
+  };
+
+  std::string volname;
+  std::string dir;
+  int use_disk;                  // sidecar directory usable
+  int nthreads;
+
+  int dims[3];
+  REAL *vol;
+  void *vmap;  size_t vmaplen;
+  hash64_t content;              // content hash of the volume file
+
+  std::vector<blob> blobs;
+  minmax_grid grid_view;         // points into the grid blob
+  volume_pyramid pyr_view;       // points into the level blobs
+
+  void* find_blob(const char* name);
+  void* get_blob(const char* name, hash64_t params, size_t bytes,
+                 std::function<void(void*)> build);
+  int   load_blob(const char* path, hash64_t params, size_t bytes, blob* b);
+  int   store_blob(const char* path, hash64_t params, size_t bytes,
+                   const void* payload);
+  void  update_content_hash(int verify);
+
+public:
+  // nthreads == 0 uses the hardware concurrency
+  preprocCache(const char* volume_file, int nthreads = 0);
+  ~preprocCache();
+
+  // map the volume and work out its content hash; 0 on failure
+  int open(int verify = 0);
+
+  REAL* volume() { return vol; }
+  void get_dims(int& x, int& y, int& z) { x = dims[0]; y = dims[1]; z = dims[2]; }
+  hash64_t content_hash() { return content; }
+
+  // Artifacts are built on first use and mapped afterwards. The
+  // memory belongs to the cache and stays valid until it is
+  // destroyed.
+  uvw* gradient(int encoding = GRADIENT_FLOAT32);
+  minmax_grid* grid();
+  const volume_stats* stats();
+  volume_pyramid* pyramid(int maxlevels = PYR_MAX_LEVELS);
+
+  // Any other artifact: a blob of bytes named name, built by build
+  // when missing or stale. params must hash every parameter the
+  // content depends on.
+  void* artifact(const char* name, hash64_t params, size_t bytes,
+                 std::function<void(void*)> build) {
+    return get_blob(name, params, bytes, build); }
+
+  int hits, misses;              // blobs mapped / (re)built
+
+  // VRLIB_NO_CACHE is not set
+  static int enabled();
+};
+
+#endif
@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////
+//
+//   Multiresolution volume pyramid
+//
+//   Level 0 is the volume itself; every further level halves
+//   the resolution.  Voxel i of level L lies at voxel i<<L of
+//   level 0, and is the [1/4 1/2 1/4] tent filtered value of
+//   level L-1 around it, so a level 0 data coordinate p maps to
+//   p/2^L at level L.  Each level has its own gradient computed
+//   from the level's values.
+//
+
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include <stddef.h>
+
+#include "render.h"
+
+#define PYR_MAX_LEVELS 8
+#define PYR_MIN_DIM    8             // no level gets smaller than this
+
+typedef struct volume_pyramid_tag
+{
+  int nlevels;
+  int dims[PYR_MAX_LEVELS][3];
+  REAL *data[PYR_MAX_LEVELS];        /* level 0 is the caller's volume */
+  uvw  *grad[PYR_MAX_LEVELS];
+  unsigned char own[PYR_MAX_LEVELS]; /* data/grad allocated by pyramid_build */
+} volume_pyramid;
+
+  /* Start with an empty pyramid */
+void pyramid_init(volume_pyramid *p);
+
+  /* Set nlevels and the level dims for a volume, at most maxlevels */
+int  pyramid_layout(volume_pyramid *p, int xdim, int ydim, int zdim,
+                    int maxlevels);
+
+  /* Filter planes [z0, z1) of a level from the level above it */
+void pyramid_downsample(REAL *src, const int sdims[3],
+                        REAL *dst, const int ddims[3], int z0, int z1);
+
+  /* Build all levels in memory.  data and grad become level 0 */
+  /* and are not copied; nthreads == 0 uses all cores */
+int  pyramid_build(volume_pyramid *p, REAL *data, uvw *grad,
+                   int xdim, int ydim, int zdim, int maxlevels,
+                   int nthreads);
+
+  /* Voxels in level 1 and coarser */
+size_t pyramid_extra_voxels(volume_pyramid *p);
+
+void pyramid_free(volume_pyramid *p);
+
+#endif
@@ -11,18 +11,27 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <strings.h>
 #include <unistd.h>
 #include <iostream>
 #include <vector>
+#include <atomic>
+#include <functional>
+#include <memory>
 
 #include "image.h"
+#include "fimage.h"
 #include "Map.h"
 #include "Trans_Stack.h"
 #include "minmax.h"
+#include "minmax_grid.h"
+#include "hash.h"
 
 #define EPS 1.0E-6
 
+#define PROGRESSIVE_PASSES 5   // see execute_progressive
+
 #define TRUE 1
 #define FALSE 0
 
@@ -44,6 +53,7 @@ static REAL eye_W[4] =  {0,0,1,0};	/* eye vector */
 static REAL light_W[4] = {0.40824829,0.40824829,0.816496,0};  
 
 void Image_to_File(image_type*, char*); 
+void image_to_ppm(image_type*, int udim, int vdim, char* fname); 
 
 ///////////////////////////////////////////////////////
 //
@@ -64,11 +74,18 @@ typedef struct _uvw
 struct interpolation_state
 {
   unsigned long offsets[8]; 
+  int cell[3];              // lower cell corner (sparse volumes)
+  const uvw* grad;          // gradient of the level sampled
   REAL tx,ty,tz; 
 }; 
 
+class sparseVolume; 
+class volumeData; 
+typedef struct volume_pyramid_tag volume_pyramid; 
+
 union VolumePtr {
   REAL* fVolume; 
+  sparseVolume* sVolume; 
 }; 
 
 //////////////////////////////////////////////////////
@@ -76,23 +93,84 @@ class volumeRender {
 public: 
 
   enum VolumeType {
-    RAW    = 1
+    RAW    = 1,
+    SPARSE = 2
   }; 
 
 protected:
 
   VolumePtr vptr; 
+  int volume_type;          // which member of vptr is set
 
   void get_bounds(); 
   void update_bounds(REAL q[4]); 
 
   uvw  *gradient;           // volume gradient
   int has_gradient; 
+  int own_gradient;         // gradient was allocated here, not passed in
+  size_t gradient_size;     // allocated uvws when own_gradient
 				 
   Map  *map;                // color map
 
   float* lookup; 
   int lookupSize; 
+  float* own_lookup;        // table read by readCmapFile (freed here)
+
+  std::atomic<int>* cancel_flag;   // stop the frame when set (not owned) 
+  int was_cancelled;        // the last frame stopped early 
+
+  // quality, see set_quality() 
+  int pixel_stride;         // trace every n-th pixel in u and v 
+  int step_scale;           // samples this many slices apart 
+  double opacity_cutoff;    // rays stop at this opacity 
+
+  // adaptive sampling, see set_adaptive() 
+  float adaptive_threshold; // 0: off 
+  int adaptive_cell; 
+  int adaptive_debug; 
+  std::vector<unsigned char> traced;   // per pixel: ray cast 
+  long rays;                // rays cast by the last frame 
+
+  // temporal reprojection: a pixel of the last frame 
+  struct history_pixel {
+    float r, g, b, a;         // the sums; a < 0: nothing landed here 
+    float x, y, z;            // opacity weighted mean sample (data space) 
+    float spread;             // and the spread of its depth, in slices 
+  }; 
+  int reproject_every;      // 0: off 
+  float reproject_spread; 
+  int history_valid, history_age; 
+  std::vector<history_pixel> history, next_history; 
+  std::vector<float> zbuffer; 
+  image_bounds_type history_b; 
+  long reused;              // pixels the last frame took over 
+
+  // sample cache, see set_sample_cache() 
+  struct cached_sample {
+    unsigned short id;        // lookup table entry, or SAMPLE_OUTSIDE 
+    unsigned short shade;     // ambient + diffuse and specular factors 
+    unsigned short spec;      // in 1/65535 of their largest values 
+  }; 
+  struct cached_ray {
+    int entry;                // first slice inside the data, or wmax+1 
+    int end;                  // first slice not cached 
+    size_t start;             // its samples in cache_samples 
+    int count; 
+  }; 
+  struct cache_key {          // what the cached samples depend on 
+    Matrix screen_to_data; 
+    int umin, umax, vmin, vmax, wmin, wmax; 
+    int zstep, level, lookupSize; 
+    float curMin, curMax; 
+  }; 
+  size_t cache_budget;      // bytes; 0: off 
+  int cache_valid; 
+  cache_key cache_view; 
+  std::vector<cached_ray> cache_rays; 
+  std::vector<cached_sample> cache_samples; 
+
+  hash64_t data_version;    // see set_data_version(); 0: unknown 
+  std::shared_ptr<const volumeData> shared_data;  // see set_data() 
 
   void set_color_map(char* mapname);  // old color map file
   void set_color_map(Map*);           // old color map file
@@ -110,10 +188,14 @@ protected:
   int rxdim, rydim, rzdim; 
 
   int udim, vdim;           // image dimensions
+  int float_output;         // fill fimage too
 
   // image bound 
   int umin, umax, vmin, vmax, wmin, wmax; 
 
+  int has_window;           // render only the pixels of the window 
+  int win_umin, win_umax, win_vmin, win_vmax; 
+
   REAL xangle, yangle, zangle; 
 
   uvw eye, light, h, eye_nonN;   // eye, light, and half vector
@@ -130,6 +212,20 @@ protected:
 
   float curMin, curMax; 
 
+  minmax_grid *mmgrid;          // optional brick min/max (not owned)
+  unsigned char *brick_empty;   // per brick: invisible under the lookup table
+  size_t brick_empty_size; 
+
+  void classify_bricks(); 
+  int in_empty_brick(REAL p[4]); 
+
+  volume_pyramid *pyramid;      // optional coarser levels (not owned)
+  int lod;                      // forced level, or -1 to pick one
+  float lod_bias;               // added to the footprint level
+  int level;                    // level used by the current frame
+
+  int select_level(); 
+
   int get_value(REAL p[4], REAL*,
                 interpolation_state*); 
 
@@ -150,11 +246,46 @@ protected:
 
 
   int mapLookup(float, float*); 
+  int mapIndex(float); 
+  void light_terms(interpolation_state*, REAL& diffuse, REAL& specular); 
 
   int check_inbound(REAL[4]); 				     
 
   void update_transform(); 
   void update_viewing(); 
+  void apply_rotation(Matrix rot); 
+
+  // what every ray of a frame needs 
+  struct ray_setup {
+    int zstep;                // slices per sample (levels are coarser) 
+    int skip_empty;           // skip bricks the lookup table hides 
+    REAL rgba[4];             // uniform volumes: the one color 
+    float* alphalut;          // uniform volumes: alpha after n samples 
+  }; 
+
+  void begin_frame(ray_setup&); 
+  void end_frame(ray_setup&); 
+  // opacity weighted sums of sample position and depth along a ray 
+  struct ray_depth {
+    REAL a, x, y, z, w, ww; 
+  }; 
+  // with zfrom the ray starts at that slice, compositing behind what 
+  // sum already holds 
+  void cast_ray(int u, int v, const ray_setup&, int zstep, REAL sum[4], 
+                ray_depth* d = NULL, int zfrom = INT_MIN); 
+  void put_pixel(int u, int v, REAL sum[4]); 
+  int  check_cancel(); 
+  void fill_cells(int stride); 
+  void trace_at(int u, int v, const ray_setup&, fimage_type* sums); 
+  void refine_cell(int u0, int u1, int v0, int v1, const ray_setup&, 
+                   fimage_type* sums); 
+  void render_adaptive(ray_setup&); 
+  void cast_history(int u, int v, const ray_setup&, history_pixel& h); 
+  void render_reprojected(ray_setup&); 
+  void make_cache_key(const ray_setup&, cache_key&); 
+  void record_ray(int u, int v, const ray_setup&, int cap, REAL sum[4]); 
+  void replay_ray(int u, int v, const ray_setup&, REAL sum[4]); 
+  void render_cached(ray_setup&); 
 
   void render();  // regular volume rendering 
 
@@ -194,11 +325,19 @@ public:
   void execute(int is_uniform = 0, 
 	       REAL mean = 0.0 ); 
 
+  // render the frame in PROGRESSIVE_PASSES passes, coarse to 
+  // exact, calling pass_done(pass, npasses) after each; the image 
+  // then holds a whole frame at that pass's quality. Returns the 
+  // passes done (fewer when cancelled). 
+  int execute_progressive(std::function<void(int pass, int npasses)> pass_done, 
+                          int is_uniform = 0, REAL mean = 0.0); 
+
   int  readCmapFile(char *filename);
 
   Matrix data_to_screen;    // transformation matrixes for 
 
   void setColorMap(int size, float* ctable); 
+  float* getColorMap(int& size) { size = lookupSize; return lookup; }
 
   // rotation angle: alpha, beta, gamma 
   void set_view(float xA, float yA, float zA);
@@ -213,10 +352,117 @@ public:
   void set_clipping_bbx(int imin, int imax, int jmin, 
 		      int jmax, int kmin, int kmax); 
 
+  // replace the volume with another one (e.g. the next timestep). 
+  // If grad is given it is used instead of computing the gradient 
+  // and is not freed by the renderer; otherwise the gradient 
+  // buffer is reused when the size allows. Call set_view() 
+  // again if the dimensions changed. 
+  void set_volume(int xdim, int ydim, int zdim, 
+                  void* volume, uvw* grad = NULL); 
+
+  // render only the box lo..hi (voxels, inclusive) of a 
+  // xdim x ydim x zdim volume, with only the box in core: data 
+  // and grad (not freed) hold the box. The view is the same as 
+  // for the whole volume, so renderers of neighbouring boxes 
+  // produce images that composite into the full one. 
+  void set_subvolume(int xdim, int ydim, int zdim, int lo[3], int hi[3], 
+                     void* data, uvw* grad); 
+
+  // render a sparse brick volume (not owned). Values, gradients 
+  // and the brick min/max grid all come from sv. 
+  void set_sparse_volume(sparseVolume* sv); 
+
+  // render shared read only data (volume_data.h): volume, gradient, 
+  // brick grid, pyramid and data version in one call. The renderer 
+  // keeps a reference until other data is set. Everything else it 
+  // holds (view, light, lookup table, quality, frame and caches) 
+  // belongs to this renderer alone, so renderers that share one 
+  // volumeData may execute() at the same time on different threads, 
+  // while one renderer is used by one thread at a time. 
+  void set_data(std::shared_ptr<const volumeData> d); 
+
+  // multiresolution levels of the in-core data (not owned, NULL 
+  // disables). A frame samples a single level: lod >= 0 forces 
+  // it, lod < 0 picks the level whose voxels match the pixel 
+  // footprint in data space, plus bias (positive is coarser, 
+  // i.e. faster, negative sharper). 
+  void set_pyramid(volume_pyramid* p); 
+  void set_lod(int lod, float bias = 0) { this->lod = lod; lod_bias = bias; }
+
+  // trade quality for time: trace every pixel_stride-th pixel in u 
+  // and v (the rest copy the nearest traced one), take samples 
+  // step_scale times further apart (opacity corrected), and end 
+  // rays at opacity cutoff. 1, 1, 0.99 is full quality. 
+  // Adaptive image space sampling (threshold > 0): rays go to the 
+  // corners of cell x cell pixel blocks first, and a block is only 
+  // split further where its corners differ by more than threshold 
+  // (r, g, b or a, 0..1) or the edge of the volume crosses it; the 
+  // rest is interpolated. With debug the image shows the pixels 
+  // that were traced in red over a darkened frame. 
+  void set_adaptive(float threshold, int cell = 8, int debug = 0) {
+    adaptive_threshold = threshold; 
+    adaptive_cell = cell < 2 ? 2 : cell; 
+    adaptive_debug = debug; 
+  }
+  long rays_cast() { return rays; }   // by the last frame 
+
+  void set_quality(int pixel_stride, int step_scale, float cutoff) {
+    this->pixel_stride = pixel_stride < 1 ? 1 : pixel_stride; 
+    this->step_scale = step_scale < 1 ? 1 : step_scale; 
+    opacity_cutoff = cutoff; 
+    history_valid = 0; 
+  }
+
+  // Temporal reprojection for small view changes (every > 0): a 
+  // frame moves the pixels of the last one to where their samples 
+  // now land and only casts rays where nothing landed, along the 
+  // edges of what did, and where the samples of a pixel were spread 
+  // over more than max_spread slices in depth. Every every-th frame 
+  // is cast in full. Shading is taken over as it was, so keep the 
+  // rotation between frames small. Full quality frames only. 
+  void set_reprojection(int every, float max_spread = 8); 
+  long reused_pixels() { return reused; }   // by the last frame 
+
+  // Keep the samples of every ray (lookup table entry and lighting, 
+  // 6 bytes a sample) in at most max_bytes (0: off). While the view 
+  // stays the same, a frame after a new lookup table only classifies 
+  // and composites what is kept; rays go into the volume only past 
+  // their cached part. The first frame of a view samples each ray 
+  // up to its share of the budget without skipping empty bricks, so 
+  // it is slower. Full quality frames only. 
+  void set_sample_cache(size_t max_bytes); 
+  // Names the data for frame_key(), e.g. the content hash of the 
+  // volume file (preprocCache::content_hash()). A new volume resets 
+  // it to 0, unknown. 
+  void set_data_version(hash64_t v) { data_version = v; }
+
+  // A hash of everything the frame execute(is_uniform, val) would 
+  // render depends on: data version, view, image size and window, 
+  // clipping, lookup table contents and quality settings. 0 when 
+  // the frame can't be cached: the data version is unknown, fimage 
+  // is wanted, or reprojection or the sample cache make the frame 
+  // depend on the ones before. 
+  hash64_t frame_key(int is_uniform = 0, REAL val = 0); 
+
+  size_t sample_cache_bytes() { 
+    return cache_rays.capacity()*sizeof(cached_ray) + 
+           cache_samples.capacity()*sizeof(cached_sample); }
+  int  get_level() { return level; }
+
+  // use a brick min/max grid of the in-core data to skip bricks 
+  // that the lookup table makes fully transparent (NULL disables) 
+  void set_minmax_grid(minmax_grid* g); 
+
 
   // update the tranformation matrix with a series of rotation and their respective axis 
   void update_rotation(std::vector<short> degrees, std::vector<char> axis);
 
+  // the rotation of set_view() followed by rot, a product of 
+  // Trans_Stack::rotate()s in data space. Unlike update_rotation 
+  // this replaces the last rotation instead of adding to it, so an 
+  // accumulated view can be set again every frame. 
+  void set_rotation(Matrix rot); 
+
   // update the data_to_screen / screen_to_data matrices in response to the change in data_to_world.
   void update_vp();
 
@@ -242,6 +488,18 @@ public:
   void get_image_dims(int& usize, int& vsize) {
                       usize = udim; vsize = vdim; }
 
+  // render only the pixels umin..umax, vmin..vmax (inclusive) of 
+  // the frame, e.g. one tile of a frame too big to render at once; 
+  // the image then covers at most the window 
+  void set_window(int umin, int umax, int vmin, int vmax); 
+  void clear_window() { has_window = 0; }
+
+  // checked before every column of pixels: once *flag is nonzero 
+  // the frame stops, leaving the columns not reached black, and 
+  // cancelled() is true until the next frame (NULL disables) 
+  void set_cancel_flag(std::atomic<int>* flag) { cancel_flag = flag; }
+  int  cancelled() { return was_cancelled; }
+
   // set the viewing bounding box in data space 
   //
   void set_viewing_bbx(int imin, int imax, int jmin, 
@@ -253,6 +511,10 @@ public:
 
   image_type *image;               // output image
 
+  // also keep the unquantized sums in fimage (for compositing)
+  void set_float_output(int on) { float_output = on; }
+  fimage_type *fimage;             // output image in floats, or NULL
+
 }; 
 
 #endif
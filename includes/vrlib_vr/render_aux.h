@@ -24,4 +24,11 @@ int vrlib_invert_matrix(Matrix cm, Matrix inv);
 void 
   pivot(Matrix m, int c, int* R,int min, int max) ; 
 
+// gradient of voxel (x,y,z); plane points at voxel (0,0,z) 
+void compute_gradient_voxel(REAL* plane, int xdim, int ydim, int zdim, 
+                            int x, int y, int z, uvw* grad); 
+
+void compute_gradient_slab(REAL* data, int xdim, int ydim, int zdim, 
+                           int z0, int z1, uvw* grad); 
+
 #endif
@@ -0,0 +1,200 @@
+/////////////////////////////////////////////////////////////////////
+//
+//                     Local Render Server
+//
+//   A long running process on a Unix socket that keeps the volumes
+//   it was asked for resident (a volumeData each, mapped through
+//   their preprocessing cache, with gradient and brick grid) and
+//   the color tables it has read.  Clients send fixed size
+//   serve_request records and get a serve_reply back for each,
+//   followed by the frame as one image block (image_new layout),
+//   in the order the server finishes them.  Requests may be sent
+//   back to back without waiting.
+//
+//   Requests wait in two queues.  Interactive ones always go first
+//   and are rendered whole.  Batch ones are rendered in bands of
+//   tile rows, and the queues are looked at again after every
+//   band, so an interactive request waits at most one band.  Among
+//   batch requests the server keeps to the volume it rendered last
+//   (up to SERVE_MAX_STREAK requests in a row) before going back
+//   to the oldest one, so requests on one data set are done
+//   together instead of alternating between volumes.
+//
+//   Several render threads (set_threads()) take requests from the
+//   queues.  Each has a view (a volumeRender) of every volume it
+//   has rendered, all views of a volume share its one volumeData,
+//   so requests on the same data set render at the same time
+//   without copies.
+//
+//   Finished frames are kept in a frameCache (frame_cache.h), so a
+//   view asked for again is sent without rendering.
+//
+//   Anyone who can connect to the socket can make the server read
+//   any file it can read as a volume or color table, so the socket
+//   must only be reachable by trusted users (its directory's
+//   permissions).  SERVE_SHUTDOWN requests are refused unless the
+//   server was created allowing them.
+//
+
+#ifndef RENDER_SERVER_H
+#define RENDER_SERVER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "render.h"
+#include "image.h"
+#include "frame_cache.h"
+#include "volume_data.h"
+
+#define SERVE_MAGIC        0x76727376     // "vrsv"
+#define SERVE_PATH         256
+#define SERVE_MAX_STREAK   16
+
+enum serve_priority {
+  SERVE_INTERACTIVE = 0,
+  SERVE_BATCH
+};
+
+enum serve_mode {
+  SERVE_FULL = 0,              // full quality
+  SERVE_PREVIEW,               // every other pixel and slice
+  SERVE_SHUTDOWN               // stop the server (no frame)
+};
+
+struct serve_request {
+  int magic;
+  int id;                      // echoed in the reply
+  int priority;                // serve_priority
+  int mode;                    // serve_mode
+  int udim, vdim;
+  float angles[3];             // alpha, beta, gamma of set_view()
+  char volume[SERVE_PATH];     // as the server sees the file system
+  char cmap[SERVE_PATH];
+};
+
+struct serve_reply {
+  int magic;
+  int id;
+  int status;                  // 1: a frame follows, 0: failed
+  float ms;                    // from arrival to finish
+  unsigned long long size;     // bytes of the image block
+};
+
+class renderServer {
+
+  // shared by the render threads
+  struct dataset {
+    std::shared_ptr<const volumeData> data;
+    std::map<std::string, colorTable> tables;
+  };
+
+  // one render thread's view of a dataset
+  struct view {
+    volumeRender vr;
+    std::string cur_table;     // the one vr uses
+    int udim, vdim;
+  };
+  typedef std::map<std::string, view*> views;
+
+  struct client {
+    int fd;
+    std::atomic<int> gone;     // hung up: drop its requests
+    std::mutex send_lock;
+    serve_request in;          // the request being read (serve loop)
+    size_t got;                // bytes of it so far
+    client(int f): fd(f), gone(0), got(0) {}
+    ~client();
+  };
+
+  struct job {
+    serve_request req;
+    std::shared_ptr<client> from;
+    double arrived;            // now() when it came in
+    image_type* frame;         // batch: the bands done so far
+    int next_band;
+    hash64_t key;              // batch: frame_key() of the whole frame
+  };
+
+  std::string path;
+  int listen_fd;
+  int wake_pipe[2];            // tells the poll loop to stop
+  int tile;
+  int allow_shutdown;
+
+  std::mutex lock;             // the queues and stop
+  std::condition_variable wake;
+  std::deque<job*> interactive, batch;
+  int stop;
+  std::string last_volume;     // of the last batch request taken
+  int streak;
+
+  std::map<std::string, dataset*> datasets;
+  std::mutex data_lock;        // datasets and their tables
+  int nthreads;
+  std::vector<std::thread> renderers;
+  frameCache frames;
+
+  double now();                // seconds, steady clock
+  void serve_loop();
+  // queue what c has sent; 0 if it hung up or sent garbage, -1 if
+  // it stopped the server
+  int  read_requests(const std::shared_ptr<client>& c);
+  void render_loop();
+  job* pick();
+  dataset* get_dataset(const char* name);
+  view* get_view(views& mine, const char* name);
+  int set_table(view* v, const char* volume, const char* cmap);
+  int render_step(views& mine, job* j);        // 1 when the frame is done
+  void reply(job* j, image_type* img);
+
+public:
+  // allow_shutdown: clients may stop the server with SERVE_SHUTDOWN
+  renderServer(int allow_shutdown = 0);
+  ~renderServer();
+
+  // listen on the socket file path (replacing a stale one); 1 on success
+  int open(const char* path);
+  void set_tile(int rows) { tile = rows > 0 ? rows : 64; }
+  // render threads (default 1, 0: one per core); before run()
+  void set_threads(int n);
+  frameCache& frame_cache() { return frames; }
+
+  // serve until shutdown() or an allowed SERVE_SHUTDOWN request
+  void run();
+  void shutdown();
+};
+
+// a small client for tools and tests
+class renderClient {
+
+  int fd;
+
+public:
+  renderClient();
+  ~renderClient();
+
+  int open(const char* path, int timeout_ms = 5000);
+  void close();
+
+  int send(const serve_request& r);
+  // the next reply; its frame (free with image_free), or NULL when
+  // the request failed or the connection broke (r->status 0)
+  image_type* receive(serve_reply* r);
+  image_type* render(const serve_request& req, serve_reply* r) {
+    return send(req) ? receive(r) : NULL; }
+};
+
+// a request with the defaults filled in
+void serve_request_init(serve_request* r, const char* volume,
+                        const char* cmap, int udim, int vdim,
+                        float alpha, float beta, float gamma);
+
+#endif
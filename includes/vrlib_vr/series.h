@@ -0,0 +1,62 @@
+/////////////////////////////////////////////////////////////////////
+//
+//                    Time-Varying Volume Series
+//
+//   Holds a sequence of volume files and feeds them to a
+//   volumeRender one timestep at a time.  While timestep t is
+//   rendered, t+1 is read, its gradient and brick min/max grid
+//   are computed on background threads.  The two timestep
+//   buffers are reused, so stepping through a series of equally
+//   sized volumes does no allocation after the first two steps.
+//
+
+#ifndef SERIES_H
+#define SERIES_H
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "render.h"
+
+class volumeSeries {
+
+  // one preprocessed timestep
+  struct timestep {
+    int t;                    // timestep held, -1 if none
+    int ok;                   // loaded without error
+    int dims[3];
+    REAL *volume;   size_t vcapacity;
+    uvw  *gradient; size_t gcapacity;
+    minmax_grid grid;
+    float vmin, vmax;         // global value range
+  };
+
+  std::vector<std::string> files;
+  timestep slots[2];
+  int cur;                    // slot bound to the renderer, -1 if none
+  int nthreads;               // workers for the gradient and grid
+
+  std::thread prefetcher;     // fills slots[1-cur]
+  int pending;                // timestep being prefetched, -1 if none
+
+  void load(timestep* ts, int t);
+  void wait_prefetch();
+
+public:
+  // nthreads == 0 uses the hardware concurrency
+  volumeSeries(const std::vector<std::string>& files, int nthreads = 0);
+  ~volumeSeries();
+
+  int num_steps() { return (int)files.size(); }
+
+  // Make timestep t the volume of vr (waiting for the prefetch
+  // if it is still running) and start preparing t+1.  Returns 0
+  // if the timestep could not be read.
+  int set_timestep(int t, volumeRender* vr);
+
+  // value range of the current timestep
+  void get_min_max(float& min, float& max);
+};
+
+#endif
@@ -0,0 +1,116 @@
+/////////////////////////////////////////////////////////////////////
+//
+//                      Interactive Render Session
+//
+//   One renderer kept for the life of a viewer.  The session owns
+//   the preprocessing cache (volume, gradient, brick grid and
+//   pyramid), the renderer and its color table, which are set up
+//   once; a frame only redoes what changed since the last one.
+//   Rotations entered one at a time are folded into a single
+//   matrix as they come, instead of being kept as a list and
+//   replayed on a new renderer every frame.
+//
+//   With start_async() the frames are rendered on a thread of the
+//   session's own, so a viewer keeps drawing while a frame renders.
+//   request() asks for a frame of the current settings; requests
+//   made while one is rendering replace each other (the latest
+//   wins) and stop the frame in progress, which is stale by then.
+//   take_frame() hands out the newest finished frame (or pass of a
+//   progressive frame).
+//
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "render.h"
+#include "preproc_cache.h"
+#include "frame_budget.h"
+
+class renderSession {
+
+  preprocCache* cache;
+  volumeRender vr;
+
+  float xangle, yangle, zangle;  // set_view()
+  Trans_Stack spin;              // rotations since set_view()
+  int view_changed;              // the renderer's matrices are stale
+
+  // async rendering; lock guards the settings above and these,
+  // render_lock the renderer
+  std::thread worker;
+  std::mutex lock, render_lock;
+  std::condition_variable wake;
+  enum { REQ_NONE, REQ_FULL, REQ_INTERACTIVE, REQ_SETTLE };
+  int async, pending, stop;
+  std::atomic<int> cancel;
+  image_type* frame;             // newest finished frame, not yet taken
+  void (*notify)();              // called when a frame is finished
+  int progressive;               // async frames coarse to fine
+  double budget_ms;              // set_frame_budget(), under lock
+  frameBudget budget;            // interactive frames, under render_lock
+
+  void publish();                // vr.image becomes the newest frame
+
+  void update_view();            // with render_lock held
+  void run();
+
+public:
+  renderSession();
+  ~renderSession();
+
+  // map (or build) the volume and what is derived from it; 1 on
+  // success
+  int  open(const char* volume_file);
+  void get_dims(int& x, int& y, int& z) { cache->get_dims(x, y, z); }
+  REAL* volume() { return cache->volume(); }
+
+  void set_image_size(int usize, int vsize);
+  int  readCmapFile(char* filename);   // only when the map changes
+
+  // the starting view; drops the rotations added since
+  void set_view(float xA, float yA, float zA);
+
+  // turn the volume deg degrees about the x, y or z axis, after
+  // the rotations so far
+  void rotate(float deg, char axis);
+
+  // render with the current settings; the image is the renderer's
+  // and stays valid until the next frame. Not while async.
+  image_type* render();
+
+  // render on the session's thread from now on. The settings can
+  // be changed at any time; set_image_size and readCmapFile wait
+  // for the frame in progress.
+  void start_async();
+  void stop_async();             // waits for the thread
+  // a frame of the current settings; interactive frames (e.g.
+  // during a rotation) keep to the frame budget, if one is set
+  void request(int interactive = 0);
+
+  // fn is called on the render thread after each finished frame,
+  // e.g. to wake an event loop (glfwPostEmptyEvent)
+  void set_frame_notify(void (*fn)()) { notify = fn; }
+
+  // async frames with volumeRender::execute_progressive: every pass
+  // is handed out as a frame, the first after a small fraction of
+  // the time of the whole frame
+  void set_progressive(int on) { progressive = on; }
+
+  // target time of interactive frames (0: none). When interaction
+  // stops, i.e. no request came in while a reduced frame rendered,
+  // a full quality frame follows by itself.
+  void set_frame_budget(double ms);
+
+  // the newest frame finished since the last call, or NULL; the
+  // caller frees it with image_free
+  image_type* take_frame();
+
+  volumeRender& renderer() { return vr; }
+};
+
+#endif
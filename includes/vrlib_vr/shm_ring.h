@@ -0,0 +1,108 @@
+/////////////////////////////////////////////////////////////////////
+//
+//              Shared Memory Ring Buffer for In-Situ Ingest
+//
+//   A POSIX shared memory segment holding a fixed number of volume
+//   slots.  A simulation (the producer) writes a timestep straight
+//   into a free slot and publishes it; the renderer (the consumer)
+//   acquires it and renders from the slot memory without copying,
+//   e.g. through volumeRender::set_volume().
+//
+//   Slots are handed over in order through two process-shared
+//   semaphores.  A producer that gets ahead of the renderer blocks
+//   in begin_write() until a slot is released (backpressure).
+//   Every published slot carries a sequence number; a consumer
+//   that only wants the newest data can skip stale slots.
+//
+//   One producer and one consumer per ring.
+//
+
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <stddef.h>
+#include <semaphore.h>
+
+#define SHM_RING_MAGIC   0x56524e47    /* "VRNG" */
+#define SHM_RING_VERSION 1
+
+typedef unsigned long long shm_seq_t;
+
+// lives at the start of the segment
+struct shm_ring_header
+{
+  unsigned int magic, version;
+  int nslots;
+  size_t slot_voxels;         // capacity of each slot
+  size_t slot_stride;         // bytes from one slot header to the next
+  sem_t empty;                // slots the producer may fill
+  sem_t full;                 // slots published to the consumer
+  volatile shm_seq_t published; // number of slots published so far
+  volatile int closed;        // producer has finished
+};
+
+// precedes the voxels of each slot
+struct shm_slot_header
+{
+  shm_seq_t seq;              // 0 for the first published timestep
+  int timestep;               // producer's own step number
+  int dims[3];
+};
+
+class shmRing {
+
+  char *name;
+  int owner;                  // created the segment (producer side)
+  size_t length;
+  shm_ring_header *hdr;
+
+  shm_seq_t write_seq;        // producer: sequence of the next slot
+  shm_seq_t read_seq;         // consumer: sequence of the next slot
+  int holding;                // consumer: slots acquired, not released
+
+  shmRing();
+  shm_slot_header* slot(shm_seq_t seq);
+
+public:
+  ~shmRing();
+
+  // producer: create (or replace) the segment /name
+  static shmRing* create(const char* name, int nslots, size_t slot_voxels);
+
+  // consumer: attach to an existing segment, retrying for up to
+  // timeout_ms while the producer has not created it yet
+  static shmRing* attach(const char* name, int timeout_ms = 0);
+
+  int    num_slots()   { return hdr->nslots; }
+  size_t slot_voxels() { return hdr->slot_voxels; }
+
+  //---------------- producer ----------------
+
+  // wait for a free slot and return its voxel buffer (NULL if the
+  // dims do not fit). Fill it, then call publish().
+  REAL* begin_write(int xdim, int ydim, int zdim, int timestep);
+  shm_seq_t publish();
+
+  // no more timesteps; wakes up a waiting consumer
+  void close();
+
+  // wait until the consumer has released every published slot, 
+  // so the segment can be unlinked without losing timesteps. 
+  // Returns 0 on timeout.
+  int wait_drained(int timeout_ms = -1);
+
+  //---------------- consumer ----------------
+
+  // Wait up to timeout_ms (< 0: forever) for the next published
+  // slot. With latest != 0, older published slots are released
+  // and only the newest one is returned. Returns NULL on timeout
+  // or when the producer closed the ring and everything has been
+  // consumed. The data stays valid until release().
+  REAL* acquire(int dims[3], shm_seq_t* seq, int* timestep,
+                int timeout_ms = -1, int latest = 0);
+
+  // give the oldest acquired slot back to the producer
+  void release();
+};
+
+#endif
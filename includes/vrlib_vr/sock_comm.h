@@ -0,0 +1,82 @@
+/////////////////////////////////////////////////////////////////////
+//
+//                  Socket Message Passing Between Renderers
+//
+//   A fully connected group of size processes, each identified by
+//   its rank, talking over stream sockets.  The endpoint string
+//   names where every rank listens:
+//
+//     unix:/tmp/prefix         rank r listens on /tmp/prefix.r
+//     tcp:host:port            all ranks on host, rank r on port+r
+//     tcp:h0,h1,...:port       rank r on host h[r], port+r
+//
+//   Every rank listens first, then connects to all lower ranks and
+//   accepts the higher ones, so the ranks may be started in any
+//   order.  Images go out as the single contiguous block image_new
+//   allocates (header and pixels), which is what the layout of
+//   image_type was made for; run length encoded images likewise.
+//
+
+#ifndef SOCK_COMM_H
+#define SOCK_COMM_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "image.h"
+#include "image_rle.h"
+
+// blocking, all of len bytes on a stream fd (retried on EINTR);
+// 0 on a broken connection
+int sock_write_all(int fd, const void* buf, size_t len);
+int sock_read_all(int fd, void* buf, size_t len);
+
+class sockComm {
+
+  int me, nranks;
+  int listen_fd;
+  std::vector<int> fds;        // one stream per peer, -1 for self
+  std::string unix_path;       // our socket file, removed by close()
+
+  int listen_on(const std::string& endpoint);
+  int connect_to(const std::string& endpoint, int peer, int timeout_ms);
+  void* recv_block(int peer, size_t* len, void* (*alloc)(size_t),
+                   void (*release)(void*));
+
+public:
+  sockComm();
+  ~sockComm();
+
+  // Join the group; returns 0 if a peer did not show up in time.
+  int open(const char* endpoint, int rank, int size,
+           int timeout_ms = 10000);
+  void close();
+
+  int rank() { return me; }
+  int size() { return nranks; }
+
+  // blocking, all of len bytes; 0 on a broken connection
+  int send(int peer, const void* buf, size_t len);
+  int recv(int peer, void* buf, size_t len);
+
+  // length prefixed messages; recv_msg returns a malloc'ed buffer
+  int   send_msg(int peer, const void* buf, size_t len);
+  void* recv_msg(int peer, size_t* len);
+
+  int send_image(int peer, image_type* img) {
+    return send_msg(peer, img, img->totalsize); }
+  // free with image_free() (image pool memory)
+  image_type* recv_image(int peer);
+
+  int send_rle(int peer, rle_image_type* img) {
+    return send_msg(peer, img, img->totalsize); }
+  // free with rle_free()
+  rle_image_type* recv_rle(int peer);
+
+  void barrier();
+
+  size_t bytes_sent;           // payload bytes since open()
+};
+
+#endif
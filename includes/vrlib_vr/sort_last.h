@@ -0,0 +1,86 @@
+/////////////////////////////////////////////////////////////////////
+//
+//                  In-process Sort-Last Renderer
+//
+//   Splits the volume into k subvolumes with a k-d tree and gives
+//   each one its own volumeRender, clipped to the subvolume but
+//   sharing the in-core volume and gradient.  A frame walks the
+//   k-d tree: the two halves of every split are handled on two
+//   threads, each leaf renders its subvolume into its own image,
+//   and every split composites its front half OVER its back half
+//   as soon as both are done, in floats (fimage.h) so that the
+//   frame is quantized only once.  Front and back follow from the
+//   side of the split plane the viewer is on, so the tree gives
+//   the visibility order for any view.
+//
+//   Neighbouring subvolumes share the voxels of their split plane
+//   but not its cells, and all renderers use the same screen space
+//   sample positions, so every sample of a full render is taken
+//   exactly once.
+//
+//   After each frame the split planes move towards balancing the
+//   render (thread CPU) time of the two halves of each split.
+//
+
+#ifndef SORT_LAST_H
+#define SORT_LAST_H
+
+#include <vector>
+
+#include "render.h"
+
+class sortLast {
+
+  struct kdnode {
+    int lo[3], hi[3];          // voxel box (inclusive)
+    int axis, split;           // split plane, internal nodes only
+    int child[2];              // lower/upper half, -1 for a leaf
+    int leaf;                  // renderer index, leaves only
+    double time;               // render seconds of the subtree, last frame
+  };
+
+  int dims[3];
+  REAL *volume;
+  uvw  *gradient;
+  int own_gradient;
+
+  std::vector<kdnode> nodes;
+  std::vector<volumeRender*> leaves;
+
+  int udim, vdim;
+  image_type *image;           // last composited frame
+  int rebalance_on;
+
+  int  build(int lo[3], int hi[3], int k);
+  void place(int n);           // push node boxes to the renderers
+  void rebalance(int n);
+  int  front_child(int n);
+  fimage_type* compose(int n);
+  void free_image();
+
+public:
+  // k subvolumes, one render thread each. grad may be NULL, the
+  // gradient is then computed here.
+  sortLast(int xdim, int ydim, int zdim, REAL* volume, uvw* grad, int k);
+  ~sortLast();
+
+  void set_minmax_grid(minmax_grid* g);
+  void set_image_size(int usize, int vsize);
+  int  readCmapFile(char* filename);
+  void set_view(float xA, float yA, float zA);
+  void update_rotation(std::vector<short> degrees, std::vector<char> axis);
+
+  // move the split planes after every frame (on by default)
+  void set_rebalance(int on) { rebalance_on = on; }
+
+  // Render and composite one frame. The image stays valid until
+  // the next call.
+  image_type* execute();
+  void out_to_image(char* fname);
+
+  int    num_subvolumes() { return (int)leaves.size(); }
+  void   get_subvolume(int i, int lo[3], int hi[3]);
+  double subvolume_time(int i);         // CPU seconds, last frame
+};
+
+#endif
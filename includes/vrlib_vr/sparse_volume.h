@@ -0,0 +1,115 @@
+/////////////////////////////////////////////////////////////////////
+//
+//                       Sparse Brick Volume
+//
+//   A volume stored as SV_BRICK^3 bricks (leaves) under a two
+//   level index, in the spirit of VDB: a coarse root grid of
+//   nodes, each node covering SV_NODE^3 bricks.  Only bricks that
+//   hold something other than the background value get memory;
+//   a brick is kept if any voxel of the brick or of its one voxel
+//   border differs from the background, so every voxel whose
+//   value or central difference gradient is not the trivial
+//   (background, zero) pair lives in an allocated brick.  Nodes
+//   whose bricks are all empty are not allocated either.
+//
+//   Values and gradients are stored per brick.  Lookups into a
+//   missing node or brick return the background value and a zero
+//   gradient without touching voxel memory, so rendering a sparse
+//   volume gives the same image as rendering the dense one.
+//
+
+#ifndef SPARSE_VOLUME_H
+#define SPARSE_VOLUME_H
+
+#include <stddef.h>
+
+#include "render.h"
+
+#define SV_SHIFT 3                      // brick edge is 1<<SV_SHIFT voxels
+#define SV_BRICK (1<<SV_SHIFT)
+#define SV_NODE_SHIFT 3                 // node edge is 1<<SV_NODE_SHIFT bricks
+#define SV_NODE (1<<SV_NODE_SHIFT)
+
+#define SV_BRICK_VOXELS (SV_BRICK*SV_BRICK*SV_BRICK)
+#define SV_NODE_BRICKS  (SV_NODE*SV_NODE*SV_NODE)
+
+struct sv_leaf {
+  REAL value[SV_BRICK_VOXELS];          // x fastest
+  uvw  grad[SV_BRICK_VOXELS];
+};
+
+struct sv_node {
+  sv_leaf* leaf[SV_NODE_BRICKS];        // NULL: background brick
+};
+
+class sparseVolume {
+
+  int xdim, ydim, zdim;
+  int bxdim, bydim, bzdim;              // bricks
+  int nxdim, nydim, nzdim;              // root nodes
+  REAL background;
+
+  sv_node** root;                       // NULL: background node
+  size_t nleaves, nnodes;
+
+  minmax_grid grid;                     // brick ranges, built with the leaves
+
+  sparseVolume(int x, int y, int z, REAL bg);
+
+  // fill bricks in slabs [bz0, bz1); planes(z0, z1) gives a
+  // pointer to voxel (0,0,z0) of data holding planes z0..z1
+  template <class P> void build_slab(int bz0, int bz1, P planes);
+  sv_node* get_node(size_t n);
+
+public:
+  ~sparseVolume();
+
+  // Build from a dense volume in memory.
+  static sparseVolume* from_dense(REAL* data, int xdim, int ydim, int zdim,
+                                  REAL background, int nthreads = 0);
+
+  // Build straight from a raw volume file, reading only a few
+  // planes per thread at a time: the dense volume never needs to
+  // be in memory.  NULL on failure.
+  static sparseVolume* from_file(const char* fname, REAL background,
+                                 int nthreads = 0);
+
+  void get_dims(int& x, int& y, int& z) { x = xdim; y = ydim; z = zdim; }
+  REAL get_background() { return background; }
+
+  // brick holding voxel (x,y,z), NULL if it is a background brick
+  inline const sv_leaf* leaf_at(int x, int y, int z) const {
+    const sv_node* n = root[(x>>(SV_SHIFT+SV_NODE_SHIFT)) + (size_t)nxdim*
+                            ((y>>(SV_SHIFT+SV_NODE_SHIFT)) + (size_t)nydim*
+                             (z>>(SV_SHIFT+SV_NODE_SHIFT)))];
+    if (n == NULL) return NULL;
+    return n->leaf[((x>>SV_SHIFT)&(SV_NODE-1)) +
+                   SV_NODE*(((y>>SV_SHIFT)&(SV_NODE-1)) +
+                            SV_NODE*((z>>SV_SHIFT)&(SV_NODE-1)))];
+  }
+  static inline int voxel_index(int x, int y, int z) {
+    return (x&(SV_BRICK-1)) +
+           SV_BRICK*((y&(SV_BRICK-1)) + SV_BRICK*(z&(SV_BRICK-1)));
+  }
+
+  REAL value(int x, int y, int z) const {
+    const sv_leaf* l = leaf_at(x, y, z);
+    return l ? l->value[voxel_index(x, y, z)] : background;
+  }
+
+  // The eight corners of the cell with lower corner (x,y,z), in
+  // the order [x1y1z1, x2y1z1, x2y2z1, x1y2z1, x1y1z2, ...] the
+  // renderer uses. Returns 0 if the cell lies in a background
+  // brick (c[] is then all background).
+  int cell_values(int x, int y, int z, REAL c[8]) const;
+  void cell_gradients(int x, int y, int z, uvw g[8]) const;
+
+  // value range per MMG_BRICK^3 brick, for empty space skipping
+  minmax_grid* get_minmax_grid() { return &grid; }
+
+  size_t allocated_bricks() { return nleaves; }
+  size_t total_bricks() { return (size_t)bxdim*bydim*bzdim; }
+  size_t bytes();                       // memory held by the index and bricks
+};
+
+#endif
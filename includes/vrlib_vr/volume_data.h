@@ -0,0 +1,93 @@
+/////////////////////////////////////////////////////////////////////
+//
+//                  Shared, Read Only Volume Data
+//
+//   Everything a renderer reads but never changes: the volume (dense
+//   or sparse), its gradient, the brick min/max grid, the resolution
+//   pyramid and a version naming the contents for frame caching.
+//   It is built once and handed around as a shared_ptr; each
+//   volumeRender that set_data()s it is one view (camera, light,
+//   lookup table, quality and its frame) and only holds a reference,
+//   so any number of views of one data set cost no extra copies and
+//   may render at the same time on different threads.  The data
+//   goes away with the last view and the last other holder.
+//
+//   colorTable is the same for a color table: read once, then any
+//   number of views point at it.
+//
+
+#ifndef VOLUME_DATA_H
+#define VOLUME_DATA_H
+
+#include <memory>
+#include <vector>
+
+#include "render.h"
+#include "hash.h"
+
+class preprocCache;
+class sparseVolume;
+
+class volumeData {
+
+  int dims[3];
+  REAL* vol;
+  sparseVolume* sparse;
+  uvw* grad;
+  minmax_grid* grid;
+  volume_pyramid* pyr;
+  hash64_t ver;
+
+  uvw* own_grad;               // computed here
+  minmax_grid own_grid;        // built here (bmin NULL when not)
+  std::shared_ptr<preprocCache> cache;   // when opened from a file
+
+  volumeData();
+
+public:
+  ~volumeData();
+
+  // A dense volume in memory, not copied (it has to outlive the
+  // data). The gradient (grad NULL) and the brick grid are computed
+  // here on nthreads threads (0: one per core).
+  static std::shared_ptr<const volumeData> make(int xdim, int ydim, int zdim,
+                                                REAL* volume, uvw* grad = NULL,
+                                                hash64_t version = 0,
+                                                int nthreads = 0);
+
+  // A volume file mapped through its preprocessing cache, with
+  // gradient, grid (and pyramid if asked for: views then pick
+  // their level, see volumeRender::set_lod()) and the content hash
+  // as version; NULL if it can't be opened.
+  static std::shared_ptr<const volumeData> open(const char* fname,
+                                                int nthreads = 0,
+                                                int with_pyramid = 0);
+
+  // A sparse volume (it carries its own gradient and grid)
+  static std::shared_ptr<const volumeData> make_sparse(sparseVolume* sv,
+                                                       hash64_t version = 0);
+
+  void get_dims(int& x, int& y, int& z) const {
+    x = dims[0]; y = dims[1]; z = dims[2]; }
+  REAL* volume() const { return vol; }
+  sparseVolume* sparse_volume() const { return sparse; }
+  uvw* gradient() const { return grad; }
+  minmax_grid* minmax() const { return grid; }
+  volume_pyramid* pyramid() const { return pyr; }
+  hash64_t version() const { return ver; }
+};
+
+// A color table file (volumeRender::readCmapFile()) and its data
+// range.  apply() only points the view at rgba (setColorMap()), so
+// the table has to outlive the views using it.
+struct colorTable {
+  std::vector<float> rgba;
+  float min, max;
+
+  colorTable(): min(0), max(0) {}
+  // 1 on success; the table is unchanged otherwise
+  int read(const char* fname);
+  void apply(volumeRender& vr) const;
+};
+
+#endif
@@ -0,0 +1,27 @@
+////////////////////////////////////////////////////////
+//
+//   Reading the raw volume files used by vrlib and testmain:
+//   three ints (xdim, ydim, zdim) followed by xdim*ydim*zdim
+//   floats.
+//
+
+#ifndef VOLUME_IO_H
+#define VOLUME_IO_H
+
+#include <stddef.h>
+
+// Read a volume file into *buf.  *buf is reused when *capacity
+// (in voxels) is large enough, otherwise it is reallocated with
+// new[].  Returns 1 on success and 0 on failure.
+int read_volume(const char* fname, int dims[3],
+                REAL** buf, size_t* capacity);
+
+// Map a volume file read-only instead of reading it. *data points
+// at the voxels inside the mapping; pass *map and *maplen to
+// unmap_volume() when done. Returns 1 on success and 0 on failure.
+int map_volume(const char* fname, int dims[3], REAL** data,
+               void** map, size_t* maplen);
+
+void unmap_volume(void* map, size_t maplen);
+
+#endif
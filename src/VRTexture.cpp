@@ -0,0 +1,89 @@
+#include <glad/glad.h>
+#include <vrlib/VRTexture.h>
+#include <vrlib_vr/minmax.h>
+
+#include <cstring>
+
+VRTexture::VRTexture(int width, int height)
+:width(width), height(height) {
+  glGenTextures(1, &tex);
+  glBindTexture(GL_TEXTURE_2D, tex);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+  glGenBuffers(1, &pbo);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+  glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)width*height*4, NULL, GL_STREAM_DRAW);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  // the first update clears all of it
+  shown.umin = 0;  shown.umax = width-1;
+  shown.vmin = 0;  shown.vmax = height-1;
+}
+
+VRTexture::~VRTexture() {
+  glDeleteBuffers(1, &pbo);
+  glDeleteTextures(1, &tex);
+}
+
+void VRTexture::update(image_type *image) {
+  // the new image within the texture
+  image_bounds_type b;
+  b.umin = MAX(image->b.umin, 0);  b.umax = MIN(image->b.umax, width-1);
+  b.vmin = MAX(image->b.vmin, 0);  b.vmax = MIN(image->b.vmax, height-1);
+  bool empty = b.umin > b.umax || b.vmin > b.vmax;
+  bool wasEmpty = shown.umin > shown.umax || shown.vmin > shown.vmax;
+
+  // upload the new image and clear what the last one left
+  image_bounds_type r = empty ? shown : b;
+  if (!empty && !wasEmpty) {
+    r.umin = MIN(b.umin, shown.umin);  r.umax = MAX(b.umax, shown.umax);
+    r.vmin = MIN(b.vmin, shown.vmin);  r.vmax = MAX(b.vmax, shown.vmax);
+  }
+  if (r.umin > r.umax || r.vmin > r.vmax) return;
+  int rw = r.umax - r.umin + 1, rh = r.vmax - r.vmin + 1;
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+  GLuint *dst = (GLuint *) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)rw*rh*4,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  if (dst == NULL) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return;
+  }
+  for (int v = r.vmin; v <= r.vmax; v++) {
+    GLuint *row = dst + (size_t)(v - r.vmin)*rw;
+    if (empty || v < b.vmin || v > b.vmax) {
+      memset(row, 0, (size_t)rw*4);
+      continue;
+    }
+    memset(row, 0, (size_t)(b.umin - r.umin)*4);
+    memset(row + (b.umax - r.umin + 1), 0, (size_t)(r.umax - b.umax)*4);
+    pixel *p = image_index(image, b.umin, v);
+    GLuint *out = row + (b.umin - r.umin);
+#if !defined(VRLIB_LONG_PIXEL) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // bytes a,b,g,r are already GL_UNSIGNED_INT_8_8_8_8 RGBA
+    memcpy(out, p, (size_t)(b.umax - b.umin + 1)*4);
+#else
+    for (int u = b.umin; u <= b.umax; u++, p++)
+      *out++ = ((GLuint)p->bp.r << 24) | ((GLuint)p->bp.g << 16) |
+               ((GLuint)p->bp.b << 8) | p->bp.a;
+#endif
+  }
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+  glBindTexture(GL_TEXTURE_2D, tex);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, r.umin, r.vmin, rw, rh,
+                  GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, (void *)0);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  if (empty) {
+    shown.umin = 0;  shown.umax = -1;  shown.vmin = 0;  shown.vmax = -1;
+  }
+  else
+    shown = b;
+}
@@ -9,13 +9,17 @@
 #include <vrlib/shader.h>
 #include <vrlib/Wireframe.h>
 #include <vrlib/Point.h>
+#include <vrlib/VRTexture.h>
 #include <vrlib/filesystem.h>
 #include <vrlib_vr/render.h>
+#include <vrlib_vr/session.h>
 #include <stb_image.h>
 
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <vector>
 #include <iterator>
 #include <fstream>
@@ -53,11 +57,10 @@ float xDeg, yDeg, zDeg;
 int xdim, ydim, zdim, udim, vdim;
 float *volume;
 char *outFP, *cmapFP;
-std::vector<short> degrees;
-std::vector<char> axes;
+renderSession session;    // volume, gradient, color table and view, kept across frames
 glm::mat4 mvp;
 
-unsigned int texture;
+VRTexture *vrTexture;     // the renderer's image, updated in place
 
 // volumeRender vr;
 
@@ -108,11 +111,11 @@ float normalizeValue(float min, float max, float x) {
 
 unsigned int initTexVAO() {
   float vertices[] = {
-      // positions        // texture coords
-      0.5f,  0.5f, 0.0f,    1.0f, 1.0f,   // top right
-      0.5f, -0.5f, 0.0f,    1.0f, 0.0f,   // bottom right
-      -0.5f, -0.5f, 0.0f,    0.0f, 0.0f,   // bottom left
-      -0.5f,  0.5f, 0.0f,    0.0f, 1.0f    // top left 
+      // positions        // texture coords (s mirrored: u runs right to left)
+      0.5f,  0.5f, 0.0f,    0.0f, 1.0f,   // top right
+      0.5f, -0.5f, 0.0f,    0.0f, 0.0f,   // bottom right
+      -0.5f, -0.5f, 0.0f,    1.0f, 0.0f,   // bottom left
+      -0.5f,  0.5f, 0.0f,    1.0f, 1.0f    // top left 
   };
 
   unsigned int indices[] = {  
@@ -145,107 +148,50 @@ unsigned int initTexVAO() {
 }
 
 void readPPM(const char *ppmFP, int &width, int &height, GLubyte **data) {
-  // read VR image data
-  std::ifstream ppmFile{ ppmFP };
-  // If we couldn't open the output file stream for reading
-  if (!ppmFile)
+  // read VR image data: binary P6 as written by out_to_image, or
+  // the older ASCII P3
+  *data = NULL;
+  FILE* ppmFile = fopen(ppmFP, "rb");
+  // If we couldn't open the file for reading
+  if (ppmFile == NULL)
   {
     // Print an error and exit
     std::cerr << "Uh oh, ppm file could not be opened for reading!" << std::endl;
+    return;
   }
 
-  std::string magicNum, widthStr, heightStr, maxValStr;
-  ppmFile >> magicNum >> widthStr >> heightStr >> maxValStr;
-
-  std::cout << "\nppm property: W - " << 
-    widthStr << ", H - " << heightStr << ", max value - " << maxValStr << '\n';
+  char magicNum[3] = { 0 };
+  int maxVal;
+  if (fscanf(ppmFile, "%2s %d %d %d", magicNum, &width, &height, &maxVal) != 4) {
+    std::cerr << "not a ppm file: " << ppmFP << std::endl;
+    fclose(ppmFile);
+    return;
+  }
+  fgetc(ppmFile);     // the single white space before the pixels
 
-  width = std::stoi(widthStr);
-  height = std::stoi(heightStr);
+  std::cout << "\nppm property: " << magicNum << " W - " << width
+            << ", H - " << height << ", max value - " << maxVal << '\n';
 
-  size_t pixelSize = width*height;
+  size_t pixelSize = (size_t)width*height;
   *data = new GLubyte[pixelSize*3];
 
-  int ppmNewlineOffset = 3;
-  for (int i=0; i < pixelSize; ++i) {
-    std::string r,g,b;
-    ppmFile >> r >> g >> b;
-    (*data)[i*3] = (GLubyte) std::stoi(r);
-    (*data)[i*3 + 1] = (GLubyte) std::stoi(g);
-    (*data)[i*3 + 2] = (GLubyte) std::stoi(b);
-    // print some of the lines to verify file reading
-    // if (i >= 38639 - ppmNewlineOffset - 1 && i <= 38647 - ppmNewlineOffset - 1) {
-    //   std::cout << i + ppmNewlineOffset + 1 << ": " << r << ", " << std::stoi(g) << ", " << std::stoi(b) << '\n';
-    // }
-  }
-}
-
-unsigned int setTexture(const char *ppmFP) {
-  // // read VR image data
-  // std::ifstream ppmFile{ ppmFP };
-  // // If we couldn't open the output file stream for reading
-  // if (!ppmFile)
-  // {
-  //   // Print an error and exit
-  //   std::cerr << "Uh oh, ppm file could not be opened for reading!" << std::endl;
-  // }
-
-  // std::string magicNum, widthStr, heightStr, maxValStr;
-  // ppmFile >> magicNum >> widthStr >> heightStr >> maxValStr;
-
-  // std::cout << "\nppm property: W - " << 
-  //   widthStr << ", H - " << heightStr << ", max value - " << maxValStr << '\n';
-
-  // int width, height, maxVal;
-  // width = std::stoi(widthStr);
-  // height = std::stoi(heightStr);
-  // maxVal = std::stoi(maxValStr);
-
-  // size_t pixelSize = width*height;
-  // GLubyte *data = new GLubyte[pixelSize*3];
-
-  // int ppmNewlineOffset = 3;
-  // for (int i=0; i < pixelSize; ++i) {
-  //   std::string r,g,b;
-  //   ppmFile >> r >> g >> b;
-  //   data[i*3] = (GLubyte) std::stoi(r);
-  //   data[i*3 + 1] = (GLubyte) std::stoi(g);
-  //   data[i*3 + 2] = (GLubyte) std::stoi(b);
-  //   // print some of the lines to verify file reading
-  //   // if (i >= 38639 - ppmNewlineOffset - 1 && i <= 38647 - ppmNewlineOffset - 1) {
-  //   //   std::cout << i + ppmNewlineOffset + 1 << ": " << r << ", " << std::stoi(g) << ", " << std::stoi(b) << '\n';
-  //   // }
-  // }
-
-  int width, height;
-  GLubyte *data;
-  readPPM(ppmFP, width, height, &data);
-
-  // configure and set textsure
-  unsigned int texture;
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture); // all upcoming GL_TEXTURE_2D operations now have effect on this texture object
-  // set the texture wrapping parameters
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	// set texture wrapping to GL_REPEAT (default wrapping method)
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  // set texture filtering parameters
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  // load image, create texture and generate mipmaps
-  if (data)
-  {
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-      glGenerateMipmap(GL_TEXTURE_2D);
+  if (strcmp(magicNum, "P6") == 0) {
+    if (fread(*data, 3, pixelSize, ppmFile) != pixelSize)
+      std::cerr << "short ppm file: " << ppmFP << std::endl;
   }
-  else
-  {
-      std::cout << "Failed to load texture" << std::endl;
+  else {
+    for (size_t i=0; i < pixelSize*3; ++i) {
+      int c = 0;
+      if (fscanf(ppmFile, "%d", &c) != 1) break;
+      (*data)[i] = (GLubyte) MIN(c, 255);
+    }
   }
-  return texture;
+  fclose(ppmFile);
 }
 
-void updateTexVR(unsigned int texture, void *data) {
-
+// stream a new vr image into the texture, no file in between
+void updateTexVR(image_type *image) {
+  vrTexture->update(image);
 }
 
 std::vector<GLfloat> normalizeArray(float rangeMin, float rangeMax, std::vector<float> numbers) {
@@ -342,56 +288,36 @@ void keyCallbackWF(GLFWwindow* window, int key, int scancode, int action, int mo
   float deg = 4.f;
 
   if (key == GLFW_KEY_ENTER && action == GLFW_PRESS) {
-    std::cout << "ENTER pressed! equal size deg vs axis: " << (degrees.size() == axes.size()) <<
-    " # of rotations: " << degrees.size()  << "\n";
-
-    // generate new vr image from user operation
-    volumeRender vr(xdim,ydim,zdim,udim,vdim,volume); 
-    vr.readCmapFile(cmapFP); 
-    vr.set_view(xDeg, yDeg, zDeg); 
-    vr.update_rotation(degrees, axes);
-    vr.execute(); 
-    vr.out_to_image(outFP);
-
-    // update the binded VR texture
-    // int width, height;
-    // GLubyte *data;
-    // readPPM(outFP, width, height, &data);
-
-    texture = setTexture(outFP);
-    // glClearColor(0.f, 1.f, 0.f, 1.0f);
-    // glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    // std::chrono::seconds dura(3);
-    // std::this_thread::sleep_for( dura );
-    // glfwMakeContextCurrent(windowTexVR);
-    // glBindTexture(GL_TEXTURE_2D, texture);
-    // glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, data);
-    // glGenerateMipmap(GL_TEXTURE_2D);
+    std::cout << "ENTER pressed!\n";
+
+    // render the accumulated view on the session's thread; the
+    // render loop shows it when it is done
+    session.request();
 
   } else if (key == GLFW_KEY_Q && action != GLFW_RELEASE) {
     mvp *= glm::rotate(glm::mat4(1.f), glm::radians(deg), glm::vec3(1.f, 0.f, 0.f));
-    degrees.push_back((short) deg);
-    axes.push_back('x');
+    session.rotate(deg, 'x');
+    session.request(1);  // stops the frame of the old view
   } else if (key == GLFW_KEY_W && action != GLFW_RELEASE) {
     mvp *= glm::rotate(glm::mat4(1.f), glm::radians(deg), glm::vec3(0.f, 1.f, 0.f));
-    degrees.push_back((short) deg);
-    axes.push_back('y');
+    session.rotate(deg, 'y');
+    session.request(1);  // stops the frame of the old view
   } else if (key == GLFW_KEY_E && action != GLFW_RELEASE) {
     mvp *= glm::rotate(glm::mat4(1.f), glm::radians(deg), glm::vec3(0.f, 0.f, 1.f));
-    degrees.push_back((short) deg);
-    axes.push_back('z');
+    session.rotate(deg, 'z');
+    session.request(1);  // stops the frame of the old view
   } else if (key == GLFW_KEY_A && action != GLFW_RELEASE) {
     mvp *= glm::rotate(glm::mat4(1.f), glm::radians(-deg), glm::vec3(1.f, 0.f, 0.f));
-    degrees.push_back((short) -deg);
-    axes.push_back('x');
+    session.rotate(-deg, 'x');
+    session.request(1);  // stops the frame of the old view
   } else if (key == GLFW_KEY_S && action != GLFW_RELEASE) {
     mvp *= glm::rotate(glm::mat4(1.f), glm::radians(-deg), glm::vec3(0.f, 1.f, 0.f));
-    degrees.push_back((short) -deg);
-    axes.push_back('y');
+    session.rotate(-deg, 'y');
+    session.request(1);  // stops the frame of the old view
   } else if (key == GLFW_KEY_D && action != GLFW_RELEASE) {
     mvp *= glm::rotate(glm::mat4(1.f), glm::radians(-deg), glm::vec3(0.f, 0.f, 1.f));
-    degrees.push_back((short) -deg);
-    axes.push_back('z');
+    session.rotate(-deg, 'z');
+    session.request(1);  // stops the frame of the old view
   }
 
 // ***********************************************************************************************************************8
@@ -400,31 +326,8 @@ void keyCallbackWF(GLFWwindow* window, int key, int scancode, int action, int mo
 void keyCallbackVR(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
   if (key == GLFW_KEY_ENTER && action == GLFW_PRESS) {
-    std::cout << "ENTER pressed! equal size deg vs axis: " << (degrees.size() == axes.size()) <<
-    " # of rotations: " << degrees.size()  << "\n";
-
-    // generate new vr image from user operation
-    volumeRender vr(xdim,ydim,zdim,udim,vdim,volume); 
-    vr.readCmapFile(cmapFP); 
-    vr.set_view(xDeg, yDeg, zDeg);
-    vr.update_rotation(degrees, axes);
-    vr.execute();
-    vr.out_to_image(outFP);
-
-    // update the binded VR texture
-    // int width, height;
-    // GLubyte *data;
-    // readPPM(outFP, width, height, &data);
-
-    texture = setTexture(outFP);
-    // glClearColor(0.f, 1.f, 0.f, 1.0f);
-    // glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    // std::chrono::seconds dura(3);
-    // std::this_thread::sleep_for( dura );
-    // glfwMakeContextCurrent(windowTexVR);
-    // glBindTexture(GL_TEXTURE_2D, texture);
-    // glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, data);
-    // glGenerateMipmap(GL_TEXTURE_2D);
+    std::cout << "ENTER pressed!\n";
+    session.request();
 
   }
 
@@ -467,30 +370,23 @@ int main(int argc, char *argv[])
 
   outFP = argv[8];
 
-  FILE* volF;
-  volF = fopen(volFP,"r"); 
-  if (volF == NULL) {
+  if (!session.open(volFP)) {
     printf(" can't open volume file %s\n", volFP); 
     exit(0);
   }
 
   printf(" read volume file %s ....\n", volFP); 
 
-  fread(&xdim, sizeof(int), 1, volF);
-  fread(&ydim, sizeof(int), 1, volF);
-  fread(&zdim, sizeof(int), 1, volF);
+  session.get_dims(xdim, ydim, zdim);
+  volume = session.volume();
 
   printf(" %d %d %d\n", xdim, ydim, zdim); 
 
-  int sizeVol = xdim*ydim*zdim;
-  volume = new float[sizeVol];
-  fread(volume, sizeof(float), sizeVol, volF);
-
-  volumeRender vr(xdim,ydim,zdim,udim,vdim,volume); 
-  vr.readCmapFile(cmapFP); 
-  vr.set_view(xDeg, yDeg, zDeg); 
-  vr.execute(); 
-  vr.out_to_image(outFP);
+  session.set_image_size(udim, vdim);
+  session.readCmapFile(cmapFP); 
+  session.set_view(xDeg, yDeg, zDeg); 
+  session.render(); 
+  session.renderer().out_to_image(outFP);
 
   /////////////////////////////////////////////////////////////////////////////////////////
   // glfw: initialize and configure
@@ -585,10 +481,18 @@ int main(int argc, char *argv[])
   Shader shaderTextureVR("shader/shader_tex.vert", "shader/shader_tex_vr.frag");
   // setup vbo, ebo, vao with VR image gl contexts
 
-  texture = setTexture(outFP);
+  vrTexture = new VRTexture(udim, vdim);
+  updateTexVR(session.renderer().image);
   unsigned int texVAO = initTexVAO();
   shaderTextureVR.use();
   shaderTextureVR.setInt("vrTexture", 0); // set texture unit manually
+
+  // from here on frames render on the session's thread; a finished
+  // frame wakes the render loop
+  session.set_frame_notify(glfwPostEmptyEvent);
+  session.set_progressive(1);      // a coarse frame first, refined in passes
+  session.set_frame_budget(40);    // ms a frame while rotating
+  session.start_async();
   
   glfwShowWindow(windowWF);
   // glfwShowWindow(windowTexVR);
@@ -645,8 +549,15 @@ int main(int argc, char *argv[])
     glClearColor(0.f, 0.f, 0.f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    // the newest finished frame, if there is one
+    image_type *frame = session.take_frame();
+    if (frame != NULL) {
+      updateTexVR(frame);
+      image_free(frame);
+    }
+
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindTexture(GL_TEXTURE_2D, vrTexture->getID());
     shaderTextureVR.use();
     glBindVertexArray(texVAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
@@ -657,6 +568,10 @@ int main(int argc, char *argv[])
     glfwWaitEvents();
   }
 
+  session.stop_async();
+  glfwMakeContextCurrent(windowTexVR);
+  delete vrTexture;
+
   // glfw: terminate, clearing all previously allocated GLFW resources.
   // ------------------------------------------------------------------
   glfwTerminate();